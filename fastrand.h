@@ -8,7 +8,8 @@
 #include "array.h"
 
 // omitting inline for not requiring C++17
-/*inline*/ static uint64_t mcg_state = 0xcafef00dd15ea5e5u;
+// thread-local for the threads of concurrent training each having their own stream
+/*inline*/ static thread_local uint64_t mcg_state = 0xcafef00dd15ea5e5u;
 /*inline*/ static uint32_t constexpr fastrand_max = UINT32_MAX;
 /*inline*/ static double constexpr fastrand_max_inverse = 1. / fastrand_max;
 /*inline*/ static double constexpr two_pi = 2 * 3.14159265358979323846;
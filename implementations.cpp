@@ -21,8 +21,19 @@ int main(int argc, char * const argv[]) {
 #endif
 
     bool shuffle = false, resume = false, write = false;
-    update(argc, argv, clauses, p, threshold, gamma, epochs, shuffle, write, resume);
-    fit(experiment, clauses, p, gamma, threshold, epochs, shuffle, write, resume);
+#if defined benchmark // serial against Hogwild-style training, on all the cores by default
+    int threads = std::max(std::thread::hardware_concurrency(), 2u);
+    update(argc, argv, clauses, p, threshold, gamma, epochs, shuffle, write, resume, threads);
+    if (resume || write) {
+        printf("Options -r and -w are not supported by the benchmark!\n");
+        return 1;
+    }
+    compare(experiment, clauses, p, gamma, threshold, epochs, shuffle, threads);
+#else
+    int threads = 1;
+    update(argc, argv, clauses, p, threshold, gamma, epochs, shuffle, write, resume, threads);
+    fit(experiment, clauses, p, gamma, threshold, epochs, shuffle, write, resume, threads);
+#endif
 
     return 0;
 }
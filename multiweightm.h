@@ -3,6 +3,8 @@
 //  © 2019 Adrian Phoulady
 //
 
+#include <thread>
+#include <vector>
 #include "weightm.h"
 
 class multiweightm {
@@ -11,6 +13,12 @@ class multiweightm {
     int const classes;
     array1d<weightm> machine;
 
+    // pick a random class other than y to train toward 0
+    int rival(int y) {
+        int zero = fastrandrange(classes - 1);
+        return zero + (zero >= y);
+    }
+
 public:
 
     // constructor
@@ -24,14 +32,38 @@ public:
 
     // train for a single input
     void train(word *x, int y) {
-        int zero = fastrandrange(classes - 1), one = y;
-        zero += zero >= one;
-        machine(zero).train(x, 0);
-        machine(one).train(x, 1);
+        machine(rival(y)).train(x, 0);
+        machine(y).train(x, 1);
+    };
+
+    // train for a single input concurrently with other threads, using this thread's scratches of the machines
+    void train(word *x, int y, array1d<weightm::scratch> &scratches) {
+        int const zero = rival(y);
+        machine(zero).train(x, 0, scratches(zero));
+        machine(y).train(x, 1, scratches(y));
+    };
+
+    // fit a single epoch in the order of idx with threads training lock-free on the shared machines, Hogwild-style
+    // each thread takes a strided share of the samples and its own random stream seeded from the calling thread's
+    void hogwild(array2d<word> &x, array1d<int> &y, array1d<int> &idx, int threads) {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t)
+            pool.emplace_back([&, t](uint64_t seed) {
+                fastsrand(seed);
+                array1d<weightm::scratch> scratches{classes};
+                for (int c = 0; c < classes; ++c)
+                    new (&scratches(c)) weightm::scratch(machine(c));
+                for (int i = t; i < x.rows; i += threads)
+                    train(x(idx(i)), y(idx(i)), scratches);
+                for (int c = 0; c < classes; ++c)
+                    scratches(c).~scratch();
+            }, fastrand());
+        for (auto &thread: pool)
+            thread.join();
     };
 
-    // fit on the input dataset
-    void fit(array2d<word> &x, array1d<int> &y, int epochs, bool mix = false) {
+    // fit on the input dataset; more than one thread opts in to the relaxed-consistency Hogwild-style training
+    void fit(array2d<word> &x, array1d<int> &y, int epochs, bool mix = false, int threads = 1) {
         array1d<int> idx{x.rows};
         // no need to serialize
         for (int i = 0; i < idx.columns; ++i)
@@ -39,8 +71,11 @@ public:
         while (epochs--) {
             if (mix)
                 shuffle(idx);
-            for (int i = 0; i < x.rows; ++i)
-                train(x(idx(i)), y(idx(i)));
+            if (threads > 1)
+                hogwild(x, y, idx, threads);
+            else
+                for (int i = 0; i < x.rows; ++i)
+                    train(x(idx(i)), y(idx(i)));
             ++epoch;
         }
     };
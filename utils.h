@@ -6,6 +6,7 @@
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -31,13 +32,13 @@ char getopt(int argc, char * const argv[], char const *optstr, char *&optarg) {
 }
 
 // read hyper-parameters from command line arguments
-void update(int argc, char * const argv[], int &clauses, double &p, int &threshold, double &gamma, int &epochs, bool &shuffle, bool &write, bool &resume) {
+void update(int argc, char * const argv[], int &clauses, double &p, int &threshold, double &gamma, int &epochs, bool &shuffle, bool &write, bool &resume, int &threads) {
     int opt;
     static char *optarg = nullptr;
-    while ((opt = getopt(argc, argv, "c:p:t:g:e:n:s:r:w:h", optarg)) != -1)
+    while ((opt = getopt(argc, argv, "c:p:t:g:e:n:s:r:w:j:h", optarg)) != -1)
         switch (opt) {
             case 'h':
-                printf("-c clauses\n-p p\n-t threshold\n-g gamma\n-e epochs\n-n new rand\n-s shuffle\n-r resume\n-w write\n");
+                printf("-c clauses\n-p p\n-t threshold\n-g gamma\n-e epochs\n-n new rand\n-s shuffle\n-r resume\n-w write\n-j threads\n");
                 break;
             case 'c':
                 clauses = atoi(optarg);
@@ -65,6 +66,9 @@ void update(int argc, char * const argv[], int &clauses, double &p, int &thresho
                 break;
             case 'w':
                 write =  strcmp(optarg, "0") && strcasecmp(optarg, "false");
+                break;
+            case 'j':
+                threads = std::max(atoi(optarg), 1);
         }
 }
 
@@ -123,9 +127,14 @@ void sample_data(array2d<word> *x, array1d<int> *y, array2d<word> *&xs, array1d<
     }
 }
 
+// wall-clock seconds since an arbitrary point; clock() adds up the time of all the threads
+double wall() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // fit a machine on the dataset for the given hyper-parameters.
-void fit(std::string const &experiment, int clauses, double p, double gamma, int threshold, int epochs, bool shuffle = false, bool write = false, bool resume = false) {
-    clock_t tc0 = clock();
+void fit(std::string const &experiment, int clauses, double p, double gamma, int threshold, int epochs, bool shuffle = false, bool write = false, bool resume = false, int threads = 1) {
+    double tw0 = wall();
 
     int features, classes;
     array2d<word> *x_train, *x_test, *x_tray;
@@ -149,17 +158,19 @@ void fit(std::string const &experiment, int clauses, double p, double gamma, int
         wtm = new multiweightm(classes, features, clauses, p, gamma, threshold);
 
     printf("samples=%dK, features=%d, classes=%d - clauses=%d, p=%.4f, gamma=%.5f, threshold=%d\n", x_train->rows / 1000, features, classes, clauses, p, gamma, threshold);
+    if (threads > 1)
+        printf("Hogwild-style training with %d threads\n", threads);
 
     while (wtm->get_epoch() < epochs) {
-        clock_t c0 = clock();
-        wtm->fit(*x_train, *y_train, 1, shuffle);
-        clock_t c1 = clock();
+        double w0 = wall();
+        wtm->fit(*x_train, *y_train, 1, shuffle, threads);
+        double w1 = wall();
         double e1 = wtm->evaluate(*x_test, *y_test);
-        clock_t c2 = clock();
+        double w2 = wall();
         double e2 = wtm->evaluate(*x_tray, *y_tray);
 
         printf("epoch %03d of training and testing -", wtm->get_epoch());
-        printf(" %04lus and %04lus -", (c1 - c0) / CLOCKS_PER_SEC, (c2 - c1) / CLOCKS_PER_SEC);
+        printf(" %04ds and %04ds -", (int) (w1 - w0), (int) (w2 - w1));
         printf(" %6.2f%%  and %6.2f%%\n", 100 * e2, 100 * e1);
     }
 
@@ -170,6 +181,39 @@ void fit(std::string const &experiment, int clauses, double p, double gamma, int
         mout.close();
     }
 
-    int ss = (clock() - tc0) / CLOCKS_PER_SEC, mm = ss / 60, hh = mm / 60;
+    int ss = wall() - tw0, mm = ss / 60, hh = mm / 60;
     printf("total time: %02d:%02d:%02d\n", hh, mm % 60, ss % 60);
 }
+
+// compare the serial fit with the Hogwild-style one in accuracy and training throughput, epoch by epoch
+void compare(std::string const &experiment, int clauses, double p, double gamma, int threshold, int epochs, bool shuffle = false, int threads = 2) {
+    threads = std::max(threads, 2); // a single thread would be the serial training again
+    int features, classes;
+    array2d<word> *x_train, *x_test;
+    array1d<int> *y_train, *y_test;
+    load_data(experiment, features, classes, x_train, y_train, x_test, y_test);
+
+    multiweightm serial{classes, features, clauses, p, gamma, threshold}, hogwild{classes, features, clauses, p, gamma, threshold};
+    double serial_time = 0, hogwild_time = 0, serial_peak = 0, hogwild_peak = 0;
+
+    printf("samples=%dK, features=%d, classes=%d - clauses=%d, p=%.4f, gamma=%.5f, threshold=%d\n", x_train->rows / 1000, features, classes, clauses, p, gamma, threshold);
+    printf("serial against Hogwild-style training with %d threads\n", threads);
+
+    for (int e = 1; e <= epochs; ++e) {
+        double w0 = wall();
+        serial.fit(*x_train, *y_train, 1, shuffle);
+        double w1 = wall();
+        hogwild.fit(*x_train, *y_train, 1, shuffle, threads);
+        double w2 = wall();
+        double a1 = serial.evaluate(*x_test, *y_test), a2 = hogwild.evaluate(*x_test, *y_test);
+
+        serial_time += w1 - w0;
+        hogwild_time += w2 - w1;
+        serial_peak = std::max(serial_peak, a1);
+        hogwild_peak = std::max(hogwild_peak, a2);
+        printf("epoch %03d - serial %9.0f samples/s %6.2f%%  and  hogwild %9.0f samples/s %6.2f%%\n", e, x_train->rows / (w1 - w0), 100 * a1, x_train->rows / (w2 - w1), 100 * a2);
+    }
+
+    printf("serial:  %9.0f samples/s, peak %6.2f%%\n", (double) epochs * x_train->rows / serial_time, 100 * serial_peak);
+    printf("hogwild: %9.0f samples/s, peak %6.2f%% - %.2fx speedup\n", (double) epochs * x_train->rows / hogwild_time, 100 * hogwild_peak, serial_time / hogwild_time);
+}
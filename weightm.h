@@ -22,6 +22,22 @@ T get(std::istream &is) {
 }
 
 class weightm {
+
+public:
+
+    // per-thread scratch of a training pass; the machine owns one for the serial training
+    struct scratch {
+        array1d<word> lmask;    // feedback mask for reward and penalty in setter feedback
+        array1d<int> clause;    // value of clauses
+
+        explicit scratch(weightm const &m)
+        : lmask{m.literals},
+          clause{m.clauses} {
+        }
+    };
+
+private:
+
     int const features;     // number of features
     int const clauses;      // number of clauses
     double const p;         // setter feedback probability
@@ -29,36 +45,63 @@ class weightm {
     int const threshold;    // weighted sum threshold for learning toward
     int const states;       // number of bits of states
     int const literals;     // number of words containing all literals
-    word const actmask;     // mask for zeroing the remaining action bits in literal words
+    word const actmask;     // mask of the literals in the last literal word, keeping the padding automata off
     array3d<word> state;    // state of all clauses in [clause, literals, bit] order
-    array1d<word> lmask;    // feedback mask for reward and penalty in setter feedback
-    array1d<int> clause;    // value of clauses
     array1d<double> weight; // weight associated to each clause
+    scratch own;            // scratch of the serial training
+
+    // read a state word or a weight, atomically if other threads may be updating it
+    template<bool concurrent, typename T>
+    static T load(T *v) {
+        if (!concurrent)
+            return *v;
+        T r;
+        __atomic_load(v, &r, __ATOMIC_RELAXED);
+        return r;
+    }
+
+    // flip the masked bits of a state word, atomically if other threads may be training the machine as well
+    template<bool concurrent>
+    static word flip(word *state_word, word mask) {
+        return concurrent? __atomic_xor_fetch(state_word, mask, __ATOMIC_RELAXED): *state_word ^= mask;
+    }
+
+    // grow or shrink the weight of a clause, with a lock-free compare-and-swap loop if concurrent
+    template<bool concurrent>
+    void reweigh(int c, bool grow) {
+        if (!concurrent) {
+            grow? weight(c) *= 1 + gamma: weight(c) /= 1 + gamma;
+            return;
+        }
+        double expected = load<true>(&weight(c)), desired;
+        do
+            desired = grow? expected * (1 + gamma): expected / (1 + gamma);
+        while (!__atomic_compare_exchange(&weight(c), &expected, &desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
 
     // increase the states of the automata
+    // concurrently, each word flip is atomic, but a carry may interleave with other threads' ones
+    template<bool concurrent>
     void add(word *state_word, word addend) {
-        for (int b = 0; addend && b < states; ++b) {
-            state_word[b] ^= addend;
-            addend &= state_word[b] ^ addend;
-        }
+        for (int b = 0; addend && b < states; ++b)
+            addend &= flip<concurrent>(&state_word[b], addend) ^ addend;
         if (addend)
             for (int b = 0; b < states; ++b)
-                state_word[b] ^= addend;
+                flip<concurrent>(&state_word[b], addend);
     }
 
     // decrease the states of the automata
+    template<bool concurrent>
     void subtract(word *state_word, word subtrahend) {
-        for (int b = 0; subtrahend && b < states; ++b) {
-            state_word[b] ^= subtrahend;
-            subtrahend &= ~(state_word[b] ^ subtrahend);
-        }
+        for (int b = 0; subtrahend && b < states; ++b)
+            subtrahend &= ~(flip<concurrent>(&state_word[b], subtrahend) ^ subtrahend);
         if (subtrahend)
             for (int b = 0; b < states; ++b)
-                state_word[b] ^= subtrahend;
+                flip<concurrent>(&state_word[b], subtrahend);
     }
 
     // prepare the feedback mask with probability p for reward and penalty in the setter feedback
-    void literal_mask() {
+    void literal_mask(array1d<word> &lmask) {
         int n = features << 1, flips = binomial(p, n);
         bool const target = flips <= features;
         // if flips are more than half, do it the other way; make 0s in an all-1 sequence
@@ -75,36 +118,39 @@ class weightm {
     }
 
     // setter feedback or feedback type I
-    void setter(int c, word const *x) {
-        literal_mask();
-        if (clause(c)) {
-            weight(c) *= 1 + gamma;
+    template<bool concurrent>
+    void setter(int c, word const *x, scratch &s) {
+        literal_mask(s.lmask);
+        if (s.clause(c)) {
+            reweigh<concurrent>(c, true);
             for (int l = 0; l < literals; ++l) {
-                add(state(c, l), x[l]);
-                subtract(state(c, l), lmask(l) & ~x[l]);
+                add<concurrent>(state(c, l), x[l]);
+                subtract<concurrent>(state(c, l), s.lmask(l) & ~x[l]);
             }
         }
         else
             for (int l = 0; l < literals; ++l)
-                subtract(state(c, l), lmask(l));
+                subtract<concurrent>(state(c, l), s.lmask(l));
     }
 
     // clearer feedback or feedback type II
-    void clearer(int c, word const *x) {
-        if (clause(c)) {
-            weight(c) /= 1 + gamma;
+    // the padding automata of the last literal word are left out, so that their action bits stay 0
+    template<bool concurrent>
+    void clearer(int c, word const *x, scratch &s) {
+        if (s.clause(c)) {
+            reweigh<concurrent>(c, false);
             for (int l = 0; l < literals; ++l)
-                add(state(c, l), ~state(c, l, states - 1) & ~x[l]);
+                add<concurrent>(state(c, l), ~load<concurrent>(&state(c, l, states - 1)) & ~x[l] & (l + 1 < literals? ~(word) 0: actmask));
         }
     }
 
     // value of a clause for an input
     // discard empty clauses instead of having them with value 1 for training == false
-    int value(int c, word const *x, bool training = false) {
+    template<bool concurrent>
+    int value(int c, word const *x, array1d<int> &clause, bool training) {
         word active = 0;
-        state(c, literals, -1) &= actmask; // == state(c, literals - 1, states - 1)
         for (int l = 0; l < literals; ++l) {
-            auto s = state(c, l, states - 1); // bit (states - 1) is the action bit of the automata
+            auto s = load<concurrent>(&state(c, l, states - 1)); // bit (states - 1) is the action bit of the automata
             if ((s & x[l]) != s)
                 return clause(c) = 0;
             active |= s;
@@ -112,6 +158,25 @@ class weightm {
         return clause(c) = training || active;
     }
 
+    // weighted sum of clauses for an input, keeping the clause values in the scratch
+    template<bool concurrent>
+    double sum(word const *x, scratch &s, bool training) {
+        double inference = 0;
+        for (int c = 0; c < clauses; ++c)
+            if (value<concurrent>(c, x, s.clause, training))
+                inference += load<concurrent>(&weight(c));
+        return inference;
+    }
+
+    // train the machine for a single input, with the clause values and the feedback mask kept in the scratch
+    template<bool concurrent>
+    void learn(word const *x, int y, scratch &s) {
+        double const diversion = .5 + (.5 - y) * sum<concurrent>(x, s, true) / threshold;
+        for (int c = 0; c < clauses; ++c)
+            if (fastrandom() < diversion)
+                y != (c & 1)? setter<concurrent>(c, x, s): clearer<concurrent>(c, x, s);
+    }
+
 
 public:
 
@@ -126,9 +191,8 @@ public:
       literals{(2 * features - 1) / word_bits + 1},
       actmask{~((bool) (2 * features % word_bits) * ~((word) 0) << 2 * features % word_bits)},
       state{clauses, literals, states},
-      lmask{literals},
-      clause{clauses},
-      weight{clauses} {
+      weight{clauses},
+      own{*this} {
         for (int c = 0; c < clauses; ++c) {
             // even clauses are positive and and odds are negative
             weight(c) = c & 1? -1: +1;
@@ -143,19 +207,18 @@ public:
 
     // get weighted sum of clauses for an input
     double infer(word const *x, bool training = false) {
-        double inference = 0;
-        for (int c = 0; c < clauses; ++c)
-            if (value(c, x, training))
-                inference += weight(c);
-        return inference;
+        return sum<false>(x, own, training);
     }
 
     // train the machine for a single input
     void train(word const *x, int y) {
-        double const diversion = .5 + (.5 - y) * infer(x, true) / threshold;
-        for (int c = 0; c < clauses; ++c)
-            if (fastrandom() < diversion)
-                y != (c & 1)? setter(c, x): clearer(c, x);
+        learn<false>(x, y, own);
+    }
+
+    // train for a single input while other threads may train the same machine on other inputs (Hogwild-style)
+    // the states and weights are updated lock-free, each thread with its own scratch; a few updates may blur
+    void train(word const *x, int y, scratch &s) {
+        learn<true>(x, y, s);
     }
 
     // fit the machine on a dataset for a number of epochs
@@ -210,9 +273,8 @@ public:
       literals{(2 * features - 1) / word_bits + 1},
       actmask{~((bool) (2 * features % word_bits) * ~((word) 0) << 2 * features % word_bits)},
       state{clauses, literals, states},
-      lmask{literals},
-      clause{clauses},
-      weight{clauses} {
+      weight{clauses},
+      own{*this} {
         mcg_state = get<uint64_t>(is);
         for (int c = 0; c < clauses; ++c)
             for (int l = 0; l < literals; ++l)
@@ -220,6 +282,9 @@ public:
                     state(c, l, b) = get<word>(is);
         for (int c = 0; c < clauses; ++c)
             weight(c) = get<double>(is);
+        // zero any action bits of the padding automata, which value does not
+        for (int c = 0; c < clauses; ++c)
+            state(c, literals, -1) &= actmask; // == state(c, literals - 1, states - 1)
     }
 
 };